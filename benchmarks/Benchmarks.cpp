@@ -30,3 +30,32 @@ TEST_CASE ("Boot performance")
         });
     };
 }
+
+TEST_CASE ("Offline render scaling")
+{
+    // Compare the two timings to see how close to linear the chunked render
+    // scales with the number of cores
+    OfflineRenderer::Settings settings;
+    juce::Random random;
+
+    juce::AudioBuffer<float> source (6, (int) settings.sampleRate * 60);
+    for (int channel = 0; channel < source.getNumChannels(); ++channel)
+        for (int i = 0; i < source.getNumSamples(); ++i)
+            source.setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+    juce::AudioBuffer<float> destination;
+
+    BENCHMARK ("Offline render of one minute, 1 thread")
+    {
+        settings.numThreads = 1;
+        return OfflineRenderer::render (source, destination, settings).wasOk();
+    };
+
+    const auto numCores = juce::SystemStats::getNumCpus();
+
+    BENCHMARK ("Offline render of one minute, " + std::to_string (numCores) + " threads")
+    {
+        settings.numThreads = numCores;
+        return OfflineRenderer::render (source, destination, settings).wasOk();
+    };
+}
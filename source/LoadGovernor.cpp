@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    Watches the processing load of the plugin and picks a quality tier for
+    the crossover, stepping down when the host gets close to its deadline
+    and back up again once there is headroom.
+
+  ==============================================================================
+*/
+
+#include "LoadGovernor.h"
+
+//==============================================================================
+LoadGovernor::LoadGovernor()
+    : overloadThreshold(0.8f),
+      recoveryThreshold(0.5f),
+      degradeTime(0.25),
+      recoverTime(2.0),
+      sampleRate(44100.0),
+      tier(Full),
+      samplesOverloaded(0),
+      samplesRecovered(0)
+{
+}
+
+//==============================================================================
+void LoadGovernor::prepare (double sampleRateIn)
+{
+    sampleRate = sampleRateIn;
+    reset();
+}
+
+void LoadGovernor::reset()
+{
+    tier = Full;
+    samplesOverloaded = 0;
+    samplesRecovered = 0;
+}
+
+LoadGovernor::Tier LoadGovernor::update (float load, int numSamples)
+{
+    // Only count time spent continuously past a threshold, anything in
+    // between the two thresholds holds the current tier (hysteresis).
+    // Nothing is counted towards a step that can't happen, so the counters
+    // stay bounded however long the load sits at one end.
+    samplesOverloaded = tier < Economy && load > overloadThreshold ? samplesOverloaded + numSamples : 0;
+    samplesRecovered = tier > Full && load < recoveryThreshold ? samplesRecovered + numSamples : 0;
+
+    if(tier < Economy && samplesOverloaded >= (int) (degradeTime * sampleRate))
+    {
+        tier = static_cast<Tier> (tier + 1);
+        samplesOverloaded = 0;
+    }
+    else if(tier > Full && samplesRecovered >= (int) (recoverTime * sampleRate))
+    {
+        tier = static_cast<Tier> (tier - 1);
+        samplesRecovered = 0;
+    }
+
+    return tier;
+}
+
+//==============================================================================
+int LoadGovernor::getNumFilterStages (Tier tierToUse)
+{
+    switch(tierToUse)
+    {
+        case Full:      return 8;
+        case Reduced:   return 4;
+        case Economy:   return 2;
+        default:        break;
+    }
+
+    jassertfalse;
+    return 8;
+}
+
+bool LoadGovernor::usesParameterSmoothing (Tier tierToUse)
+{
+    return tierToUse != Economy;
+}
+
+juce::StringArray LoadGovernor::getTierNames()
+{
+    return { "Full", "Reduced", "Economy" };
+}
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    Watches the processing load of the plugin and picks a quality tier for
+    the crossover, stepping down when the host gets close to its deadline
+    and back up again once there is headroom.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+*/
+class LoadGovernor
+{
+public:
+    //==============================================================================
+    enum Tier { Full, Reduced, Economy, numTiers };
+
+    LoadGovernor();
+
+    //==============================================================================
+    void prepare (double sampleRate);
+    void reset();
+
+    // Feed in the load of the last block (render time / block duration) and
+    // get back the tier the next block should be rendered with.
+    Tier update (float load, int numSamples);
+
+    Tier getTier() const { return tier; }
+
+    static int getNumFilterStages (Tier tierToUse);
+    static bool usesParameterSmoothing (Tier tierToUse);
+    static juce::StringArray getTierNames();
+
+    //==============================================================================
+    // Load above which we start counting towards stepping down a tier
+    float overloadThreshold;
+    // Load below which we start counting towards stepping back up a tier
+    float recoveryThreshold;
+
+    // How long the load has to stay past a threshold before switching, in seconds
+    double degradeTime, recoverTime;
+
+private:
+    //==============================================================================
+    double sampleRate;
+    Tier tier;
+    int samplesOverloaded, samplesRecovered;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadGovernor)
+};
@@ -0,0 +1,474 @@
+/*
+  ==============================================================================
+
+    Renders a long 5.1 buffer or file through the bass manager on every core.
+
+    The input is split into chunks that are rendered concurrently. Each chunk
+    starts its filters from silence a little before the chunk proper, long
+    enough for the IIR tails to decay below the error bound, so the stitched
+    output matches a sequential render within that bound.
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include <condition_variable>
+#include <mutex>
+
+//==============================================================================
+namespace
+{
+    // Samples until the free response of a pole of the given radius, repeated
+    // multiplicity times, falls below bound. Its envelope is C(n + m - 1, m - 1) r^n,
+    // so carry on while that is still rising or above the bound.
+    int getDecayLength (double poleRadius, int multiplicity, double bound)
+    {
+        jassert (poleRadius < 1.0);
+
+        double envelope = 1.0;
+        int n = 0;
+
+        while (envelope >= bound || poleRadius * (n + multiplicity) / (n + 1) >= 1.0)
+        {
+            ++n;
+            envelope *= poleRadius * (n + multiplicity - 1) / n;
+        }
+
+        return n;
+    }
+
+    struct FilterSection
+    {
+        double b0, b1, b2, a1, a2, z1 = 0.0, z2 = 0.0;
+
+        double process (double x)
+        {
+            auto y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    FilterSection makeFirstOrderHighPass (double frequency, double sampleRate)
+    {
+        auto n = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+        return { 1.0 / (1.0 + n), -1.0 / (1.0 + n), 0.0, (n - 1.0) / (n + 1.0), 0.0 };
+    }
+
+    FilterSection makeButterworthLowPass (double frequency, double sampleRate)
+    {
+        auto k = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+        auto norm = 1.0 / (1.0 + juce::MathConstants<double>::sqrt2 * k + k * k);
+        return { k * k * norm, 2.0 * k * k * norm, k * k * norm, 2.0 * (k * k - 1.0) * norm, (1.0 - juce::MathConstants<double>::sqrt2 * k + k * k) * norm };
+    }
+
+    // tail[k] is the sum of |h[j]| for j >= k over the impulse response of the
+    // cascade. Leaving out every input more than k samples back moves the output
+    // by at most tail[k] times the input's peak, whatever state the filters are in.
+    std::vector<double> getTailMass (std::vector<FilterSection> sections, int length)
+    {
+        std::vector<double> tail ((size_t) length + 1, 0.0);
+
+        for (int i = 0; i < length; ++i)
+        {
+            auto y = i == 0 ? 1.0 : 0.0;
+
+            for (auto& section : sections)
+                y = section.process (y);
+
+            tail[(size_t) i] = std::abs (y);
+        }
+
+        for (int i = length - 1; i >= 0; --i)
+            tail[(size_t) i] += tail[(size_t) i + 1];
+
+        return tail;
+    }
+
+    struct ChunkPlan
+    {
+        int primingLength, chunkSize, numChunks, numWorkers;
+
+        ChunkPlan (juce::int64 numSamples, const OfflineRenderer::Settings& settings)
+        {
+            auto numThreads = settings.numThreads > 0 ? settings.numThreads : juce::SystemStats::getNumCpus();
+            primingLength = OfflineRenderer::getPrimingLength (settings);
+
+            if (settings.chunkSize > 0)
+            {
+                chunkSize = settings.chunkSize;
+            }
+            else
+            {
+                // Aim for a few chunks per thread to even out the load. Keep chunks long
+                // enough that priming doesn't dominate, and short enough that a long file
+                // only ever has a few of them in memory.
+                auto shortest = juce::jmax (primingLength * 4, settings.blockSize);
+                auto longest = juce::jmax (shortest, 1 << 20);
+                chunkSize = (int) juce::jlimit ((juce::int64) shortest, (juce::int64) longest, (numSamples + numThreads * 4 - 1) / (numThreads * 4));
+            }
+
+            numChunks = (int) ((numSamples + chunkSize - 1) / chunkSize);
+            numWorkers = juce::jmin (numThreads, numChunks);
+        }
+
+        juce::int64 getChunkStart (int chunk) const { return (juce::int64) chunk * chunkSize; }
+        juce::int64 getPrimingStart (int chunk) const { return juce::jmax ((juce::int64) 0, getChunkStart (chunk) - primingLength); }
+    };
+
+    // Processors are created on the calling thread, each worker then reuses its own
+    // for every chunk it picks up
+    void createProcessors (juce::OwnedArray<BassicManagerAudioProcessor>& processors, int numWorkers, const OfflineRenderer::Settings& settings)
+    {
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            auto* processor = processors.add (new BassicManagerAudioProcessor());
+            processor->setNonRealtime (true);
+            processor->setParameterValue ("crossoverFrequency", settings.crossoverFrequency);
+            processor->setParameterValue ("lfeLowPassFrequency", settings.lfeLowPassFrequency);
+        }
+    }
+
+    // Runs the first length samples of chunkBuffer through the processor in place
+    void processChunk (BassicManagerAudioProcessor& processor, juce::AudioBuffer<float>& chunkBuffer, int length, const OfflineRenderer::Settings& settings)
+    {
+        // prepareToPlay clears every filter, so each chunk starts from silence
+        processor.prepareToPlay (settings.sampleRate, settings.blockSize);
+
+        juce::MidiBuffer midiBuffer;
+        juce::AudioBuffer<float> blockBuffer;
+
+        for (int i = 0; i < length; i += settings.blockSize)
+        {
+            auto subBlockSize = juce::jmin (settings.blockSize, length - i);
+            blockBuffer.setDataToReferTo (chunkBuffer.getArrayOfWritePointers(), chunkBuffer.getNumChannels(), i, subBlockSize);
+
+            processor.processBlock (blockBuffer, midiBuffer);
+        }
+    }
+}
+
+//==============================================================================
+juce::Result OfflineRenderer::validate (const Settings& settings)
+{
+    // Keeps every filter pole inside the unit circle, so the priming length is finite
+    if (! (settings.sampleRate > 2.0 * BassicManagerAudioProcessor::maxFrequency))
+        return juce::Result::fail ("Sample rate must be above " + juce::String (2.0f * BassicManagerAudioProcessor::maxFrequency) + "Hz");
+
+    if (! std::isfinite (settings.crossoverFrequency) || ! std::isfinite (settings.lfeLowPassFrequency))
+        return juce::Result::fail ("Crossover and LFE low pass frequencies must be finite");
+
+    if (settings.blockSize <= 0)
+        return juce::Result::fail ("Block size must be positive");
+
+    if (! (settings.errorBound > 0.0f))
+        return juce::Result::fail ("Error bound must be positive");
+
+    if (settings.numThreads < 0 || settings.chunkSize < 0)
+        return juce::Result::fail ("Thread count and chunk size can't be negative");
+
+    return juce::Result::ok();
+}
+
+OfflineRenderer::Settings OfflineRenderer::clampToParameterRanges (Settings settings)
+{
+    // The processors get their frequencies through parameters, which clamp them,
+    // so the priming has to be sized for the same clamped values
+    settings.crossoverFrequency = juce::jlimit (BassicManagerAudioProcessor::minFrequency, BassicManagerAudioProcessor::maxFrequency, settings.crossoverFrequency);
+    settings.lfeLowPassFrequency = juce::jlimit (BassicManagerAudioProcessor::minFrequency, BassicManagerAudioProcessor::maxFrequency, settings.lfeLowPassFrequency);
+    return settings;
+}
+
+int OfflineRenderer::getPrimingLength (const Settings& requestedSettings)
+{
+    if (validate (requestedSettings).failed())
+        return 0;
+
+    auto settings = clampToParameterRanges (requestedSettings);
+
+    // Pole radii of the satellite high-pass (8 identical first order stages) and
+    // the Linkwitz-Riley low-passes (two identical Butterworth biquads each)
+    auto n = std::tan (juce::MathConstants<double>::pi * settings.crossoverFrequency / settings.sampleRate);
+    auto highPassRadius = std::abs ((1.0 - n) / (1.0 + n));
+
+    auto linkwitzRileyRadius = [&] (double frequency) {
+        auto k = std::tan (juce::MathConstants<double>::pi * frequency / settings.sampleRate);
+        return std::sqrt ((1.0 - juce::MathConstants<double>::sqrt2 * k + k * k) / (1.0 + juce::MathConstants<double>::sqrt2 * k + k * k));
+    };
+
+    // Only look this far out. The pole envelopes put whatever lies past it a
+    // thousand times below the bound.
+    double bound = settings.errorBound;
+    auto horizon = 2 * juce::jmax (getDecayLength (highPassRadius, 8, bound * 1.0e-3),
+                           getDecayLength (linkwitzRileyRadius (settings.crossoverFrequency), 2, bound * 1.0e-3),
+                           getDecayLength (linkwitzRileyRadius (settings.lfeLowPassFrequency), 2, bound * 1.0e-3));
+
+    auto highPass = makeFirstOrderHighPass (settings.crossoverFrequency, settings.sampleRate);
+    auto sumLowPass = makeButterworthLowPass (settings.crossoverFrequency, settings.sampleRate);
+    auto lfeLowPass = makeButterworthLowPass (settings.lfeLowPassFrequency, settings.sampleRate);
+
+    auto satelliteTail = getTailMass (std::vector<FilterSection> (8, highPass), horizon);
+    auto sumTail = getTailMass ({ sumLowPass, sumLowPass }, horizon);
+    auto lfeTail = getTailMass ({ lfeLowPass, lfeLowPass }, horizon);
+
+    // The LFE output sees its own input boosted by 10dB plus the sum of all five
+    // satellites, each of which can be at full scale
+    auto lfeGain = juce::Decibels::decibelsToGain (10.0);
+
+    for (int length = 0; length < horizon; ++length)
+        if (satelliteTail[(size_t) length] <= bound && lfeGain * lfeTail[(size_t) length] + 5.0 * sumTail[(size_t) length] <= bound)
+            return length;
+
+    return horizon;
+}
+
+
+juce::Result OfflineRenderer::render (const juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& destination, const Settings& requestedSettings)
+{
+    if (source.getNumChannels() != 6)
+        return juce::Result::fail ("Expected the 6 channels of a 5.1 layout, got " + juce::String (source.getNumChannels()));
+
+    if (&source == &destination)
+        return juce::Result::fail ("Can't render a buffer in place");
+
+    auto validation = validate (requestedSettings);
+
+    if (validation.failed())
+        return validation;
+
+    auto settings = clampToParameterRanges (requestedSettings);
+
+    auto numSamples = source.getNumSamples();
+    destination.setSize (source.getNumChannels(), numSamples, false, false, true);
+
+    if (numSamples == 0)
+        return juce::Result::ok();
+
+    ChunkPlan plan (numSamples, settings);
+
+    juce::OwnedArray<BassicManagerAudioProcessor> processors;
+    createProcessors (processors, plan.numWorkers, settings);
+
+    // Chunks write to disjoint ranges of these, so the workers never touch destination itself
+    auto destinationChannels = destination.getArrayOfWritePointers();
+
+    std::atomic<int> nextChunk { 0 }, workersRunning { plan.numWorkers };
+    juce::WaitableEvent allChunksRendered;
+    juce::ThreadPool pool (plan.numWorkers);
+
+    for (auto* processor : processors)
+    {
+        pool.addJob ([&, processor] {
+            juce::AudioBuffer<float> chunkBuffer (source.getNumChannels(), plan.chunkSize + plan.primingLength);
+
+            for (int chunk = nextChunk++; chunk < plan.numChunks; chunk = nextChunk++)
+            {
+                auto chunkStart = (int) plan.getChunkStart (chunk);
+                auto primingStart = (int) plan.getPrimingStart (chunk);
+                auto chunkEnd = juce::jmin (chunkStart + plan.chunkSize, numSamples);
+
+                for (int channel = 0; channel < source.getNumChannels(); ++channel)
+                    chunkBuffer.copyFrom (channel, 0, source, channel, primingStart, chunkEnd - primingStart);
+
+                processChunk (*processor, chunkBuffer, chunkEnd - primingStart, settings);
+
+                // Only the part after the priming region goes to the output
+                for (int channel = 0; channel < source.getNumChannels(); ++channel)
+                    juce::FloatVectorOperations::copy (destinationChannels[channel] + chunkStart,
+                        chunkBuffer.getReadPointer (channel, chunkStart - primingStart),
+                        chunkEnd - chunkStart);
+            }
+
+            if (--workersRunning == 0)
+                allChunksRendered.signal();
+
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+
+    allChunksRendered.wait();
+
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::renderFile (const juce::File& sourceFile, const juce::File& destinationFile, Settings settings)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (sourceFile));
+
+    if (reader == nullptr)
+        return juce::Result::fail ("Couldn't read " + sourceFile.getFullPathName());
+
+    if (reader->numChannels != 6)
+        return juce::Result::fail (sourceFile.getFileName() + " isn't a 5.1 file");
+
+    settings.sampleRate = reader->sampleRate;
+
+    auto validation = validate (settings);
+
+    if (validation.failed())
+        return validation;
+
+    settings = clampToParameterRanges (settings);
+
+    ChunkPlan plan (reader->lengthInSamples, settings);
+
+    // Readers aren't thread-safe, so every worker reads its chunks through its own
+    juce::OwnedArray<juce::AudioFormatReader> workerReaders;
+
+    for (int i = 0; i < plan.numWorkers; ++i)
+        if (workerReaders.add (formatManager.createReaderFor (sourceFile)) == nullptr)
+            return juce::Result::fail ("Couldn't read " + sourceFile.getFullPathName());
+
+    juce::OwnedArray<BassicManagerAudioProcessor> processors;
+    createProcessors (processors, plan.numWorkers, settings);
+
+    // Render into a temporary file, so an existing destination is only replaced
+    // once the whole render has succeeded
+    juce::TemporaryFile temporaryFile (destinationFile);
+    std::unique_ptr<juce::OutputStream> outputStream (temporaryFile.getFile().createOutputStream());
+
+    if (outputStream == nullptr)
+        return juce::Result::fail ("Couldn't open " + destinationFile.getFullPathName() + " for writing");
+
+    // Always 32 bit float, whatever the source was. The boosted LFE plus the summed
+    // satellites routinely goes past full scale, which an integer format would clip.
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer (wavFormat.createWriterFor (outputStream.get(),
+        reader->sampleRate,
+        reader->numChannels,
+        32,
+        reader->metadataValues,
+        0));
+
+    if (writer == nullptr)
+        return juce::Result::fail ("Couldn't create a WAV writer for " + destinationFile.getFullPathName());
+
+    // The writer owns the stream from here on
+    outputStream.release();
+
+    // Finished chunks wait in a slot until the writer has written everything before
+    // them. Chunk n always uses slot n % numSlots, and a worker only starts on it once
+    // the chunk that last used that slot has been written, so memory stays at
+    // numSlots chunks however long the file is.
+    struct Slot
+    {
+        juce::AudioBuffer<float> buffer;
+        bool ready = false;
+    };
+
+    auto numSlots = plan.numWorkers * 2;
+    std::vector<Slot> slots ((size_t) numSlots);
+
+    for (auto& slot : slots)
+        slot.buffer.setSize ((int) reader->numChannels, plan.chunkSize + plan.primingLength);
+
+    std::mutex mutex;
+    std::condition_variable slotsChanged;
+    int chunksWritten = 0, workersRunning = plan.numWorkers;
+    juce::String error;
+
+    std::atomic<int> nextChunk { 0 };
+    juce::ThreadPool pool (juce::jmax (1, plan.numWorkers));
+
+    for (int worker = 0; worker < plan.numWorkers; ++worker)
+    {
+        pool.addJob ([&, worker] {
+            auto& workerReader = *workerReaders[worker];
+            auto& processor = *processors[worker];
+
+            for (int chunk = nextChunk++; chunk < plan.numChunks; chunk = nextChunk++)
+            {
+                auto& slot = slots[(size_t) (chunk % numSlots)];
+
+                {
+                    std::unique_lock<std::mutex> lock (mutex);
+                    slotsChanged.wait (lock, [&] { return error.isNotEmpty() || chunk < chunksWritten + numSlots; });
+
+                    if (error.isNotEmpty())
+                        break;
+                }
+
+                auto primingStart = plan.getPrimingStart (chunk);
+                auto length = (int) (juce::jmin (plan.getChunkStart (chunk) + plan.chunkSize, reader->lengthInSamples) - primingStart);
+
+                auto wasRead = workerReader.read (&slot.buffer, 0, length, primingStart, true, true);
+
+                if (wasRead)
+                    processChunk (processor, slot.buffer, length, settings);
+
+                {
+                    std::lock_guard<std::mutex> lock (mutex);
+
+                    if (wasRead)
+                        slot.ready = true;
+                    else if (error.isEmpty())
+                        error = "Couldn't read " + sourceFile.getFullPathName();
+                }
+
+                slotsChanged.notify_all();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                --workersRunning;
+            }
+
+            slotsChanged.notify_all();
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+
+    // Write the chunks in order on this thread as they come in
+    for (int chunk = 0; chunk < plan.numChunks; ++chunk)
+    {
+        auto& slot = slots[(size_t) (chunk % numSlots)];
+
+        {
+            std::unique_lock<std::mutex> lock (mutex);
+            slotsChanged.wait (lock, [&] { return error.isNotEmpty() || slot.ready; });
+
+            if (error.isNotEmpty())
+                break;
+        }
+
+        auto chunkStart = plan.getChunkStart (chunk);
+        auto chunkEnd = juce::jmin (chunkStart + plan.chunkSize, reader->lengthInSamples);
+        auto wasWritten = writer->writeFromAudioSampleBuffer (slot.buffer, (int) (chunkStart - plan.getPrimingStart (chunk)), (int) (chunkEnd - chunkStart));
+
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+
+            if (wasWritten)
+            {
+                slot.ready = false;
+                ++chunksWritten;
+            }
+            else if (error.isEmpty())
+            {
+                error = "Couldn't write " + destinationFile.getFullPathName();
+            }
+        }
+
+        slotsChanged.notify_all();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock (mutex);
+        slotsChanged.wait (lock, [&] { return workersRunning == 0; });
+    }
+
+    if (error.isNotEmpty())
+        return juce::Result::fail (error);
+
+    // Flush and close the file before it replaces the destination
+    writer.reset();
+
+    if (! temporaryFile.overwriteTargetFileWithTemporary())
+        return juce::Result::fail ("Couldn't replace " + destinationFile.getFullPathName());
+
+    return juce::Result::ok();
+}
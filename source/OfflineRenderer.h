@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    Renders a long 5.1 buffer or file through the bass manager on every core.
+
+    The input is split into chunks that are rendered concurrently. Each chunk
+    starts its filters from silence a little before the chunk proper, long
+    enough for the IIR tails to decay below the error bound, so the stitched
+    output matches a sequential render within that bound.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/**
+*/
+class OfflineRenderer
+{
+public:
+    //==============================================================================
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        float crossoverFrequency = 60.0f;
+        float lfeLowPassFrequency = 120.0f;
+        int blockSize = 512;
+
+        // Largest deviation from a sequential render for any input within full scale,
+        // on top of the float rounding both renders already have
+        float errorBound = 1.0e-6f;
+
+        // 0 uses every core
+        int numThreads = 0;
+
+        // 0 picks a size from the length of the input and the number of threads
+        int chunkSize = 0;
+    };
+
+    //==============================================================================
+    // source must have the 6 channels of the plugin's 5.1 layout and can't be destination.
+    // The frequencies are clamped to the plugin's parameter ranges.
+    static juce::Result render (const juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& destination, const Settings& settings);
+
+    // The sample rate is taken from the source file, the output is written as 32 bit
+    // float WAV whatever the source format, so an LFE pushed past full scale isn't clipped.
+    // The file is streamed: workers read only the chunks they render and the chunks
+    // are written in order, so about two chunks per thread are held in memory
+    // however long the file is. An existing destination is only replaced on success.
+    static juce::Result renderFile (const juce::File& sourceFile, const juce::File& destinationFile, Settings settings);
+
+    // Number of samples each chunk is primed over before its output is used,
+    // or 0 for settings that render would reject
+    static int getPrimingLength (const Settings& settings);
+
+private:
+    //==============================================================================
+    static juce::Result validate (const Settings& settings);
+    static Settings clampToParameterRanges (Settings settings);
+};
@@ -28,20 +28,35 @@ BassicManagerAudioProcessor::BassicManagerAudioProcessor()
                       {
                             std::make_unique<juce::AudioParameterFloat> ("crossoverFrequency",
                                                          "Crossover Frequency",
-                                                         20.0f,
-                                                         250.0f,
+                                                         minFrequency,
+                                                         maxFrequency,
                                                          60.0f),
                             std::make_unique<juce::AudioParameterFloat> ("lfeLowPassFrequency",
                                                                        "LFE Low Pass Frequency",
-                                                                       20.0f,
-                                                                       250.0f,
+                                                                       minFrequency,
+                                                                       maxFrequency,
                                                                        120.0f),
                             std::make_unique<juce::AudioParameterBool> ("lfeBoost",
                                                                       "LFE Boost",
-                                                                      false)
-                      })
+                                                                      false),
+                            std::make_unique<juce::AudioParameterBool> ("cpuGovernor",
+                                                                      "CPU Governor",
+                                                                      false),
+                            // Read-only, reports the tier picked by the governor. Hosts that honour the
+                            // meter category show it as a read-out, the generic editor still offers a
+                            // choice but anything picked there is overwritten on the next block
+                            std::make_unique<juce::AudioParameterChoice> ("qualityTier",
+                                                                        "Quality Tier",
+                                                                        LoadGovernor::getTierNames(),
+                                                                        LoadGovernor::Full,
+                                                                        juce::AudioParameterChoiceAttributes().withAutomatable(false).withCategory(juce::AudioProcessorParameter::otherMeter))
+                      }),
+        activeFilterStages(LoadGovernor::getNumFilterStages(LoadGovernor::Full)),
+        fadeTargetFilterStages(activeFilterStages)
 #endif
 {
+    qualityTierParameter = dynamic_cast<juce::AudioParameterChoice*> (parameters.getParameter("qualityTier"));
+    
     // Setup satellite speaker filters
     for(int i=0; i<5; i++)
     {
@@ -141,9 +156,24 @@ void BassicManagerAudioProcessor::prepareToPlay (double sampleRate, int samplesP
     sumBuffer.setSize(1, samplesPerBlock);
     sumBuffer.clear();
     
+    crossfadeBuffer.setSize(5, samplesPerBlock);
+    crossfadeBuffer.clear();
+    crossfadeGains.setSize(1, samplesPerBlock);
+    
+    loadMeasurer.reset(sampleRate, samplesPerBlock);
+    loadGovernor.prepare(sampleRate);
+    activeFilterStages = fadeTargetFilterStages = LoadGovernor::getNumFilterStages(loadGovernor.getTier());
+    
+    tierCrossfade.reset(sampleRate, tierCrossfadeTime);
+    tierCrossfade.setCurrentAndTargetValue(1.0f);
+    
     crossoverFrequency.reset(sampleRate, 0.001);
     lfeLowPassFrequency.reset(sampleRate, 0.001);
     
+    // Start from the current parameter values rather than ramping in from the defaults
+    crossoverFrequency.setCurrentAndTargetValue(*parameters.getRawParameterValue("crossoverFrequency"));
+    lfeLowPassFrequency.setCurrentAndTargetValue(*parameters.getRawParameterValue("lfeLowPassFrequency"));
+    
     updateCrossoverFrequency(sampleRate);
     lfeLowPassFilter.setCutoffFrequency(lfeLowPassFrequency.getNextValue());
 }
@@ -195,9 +225,32 @@ void BassicManagerAudioProcessor::updateCrossoverFrequency(double sampleRate)
     sumLowPassFilter.setCutoffFrequency(crossoverFrequency.getNextValue());
 }
 
+void BassicManagerAudioProcessor::setParameterValue(const juce::String& parameterID, float value)
+{
+    auto parameter = parameters.getParameter(parameterID);
+    jassert(parameter != nullptr);
+    
+    if(parameter != nullptr)
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+void BassicManagerAudioProcessor::updateQualityTier(int numSamples)
+{
+    // Offline renders have no deadline to miss, so they always get the full tier
+    if(*parameters.getRawParameterValue("cpuGovernor") > 0.5f && ! isNonRealtime())
+        loadGovernor.update(static_cast<float> (loadMeasurer.getLoadAsProportion()), numSamples);
+    else
+        loadGovernor.reset();
+    
+    // The tier parameter is read-only, so keep it in step with the governor
+    if(qualityTierParameter->getIndex() != loadGovernor.getTier())
+        *qualityTierParameter = loadGovernor.getTier();
+}
+
 void BassicManagerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer (loadMeasurer, buffer.getNumSamples());
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -210,6 +263,8 @@ void BassicManagerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
+    updateQualityTier(buffer.getNumSamples());
+    
     // Sum the full range channels to a new buffer and lowPass
     
     sumBuffer.copyFrom(0, 0, buffer, CHANNELS::L, 0, buffer.getNumSamples());
@@ -218,11 +273,51 @@ void BassicManagerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
     sumBuffer.addFrom(0, 0, buffer, CHANNELS::LS, 0, buffer.getNumSamples());
     sumBuffer.addFrom(0, 0, buffer, CHANNELS::RS, 0, buffer.getNumSamples());
     
-    AudioBlock<float> sumBufferBlock(sumBuffer);
+    // Only filter the part of sumBuffer this block uses, so shorter blocks don't push stale samples through the filter
+    AudioBlock<float> sumBufferBlock = AudioBlock<float>(sumBuffer).getSubBlock(0, (size_t) buffer.getNumSamples());
     ProcessContextReplacing<float> sumBufferContext(sumBufferBlock);
     sumLowPassFilter.process(sumBufferContext);
     
     // Replace the full range output high-passed
+    // If the governor changed the cascade order, run the longer cascade and
+    // crossfade from the old order to the new one over tierCrossfadeTime,
+    // however many blocks that takes. Tier changes during a fade wait for it to end.
+    
+    auto numSamples = buffer.getNumSamples();
+    
+    if(! tierCrossfade.isSmoothing())
+    {
+        auto targetFilterStages = LoadGovernor::getNumFilterStages(loadGovernor.getTier());
+        
+        if(targetFilterStages != activeFilterStages)
+        {
+            // Stages coming back in have stale state, so start them clean
+            for(auto* filterArray : filterArrays)
+                for(int j=activeFilterStages; j<targetFilterStages; j++)
+                    filterArray->getUnchecked(j)->reset();
+            
+            fadeTargetFilterStages = targetFilterStages;
+            tierCrossfade.setCurrentAndTargetValue(0.0f);
+            tierCrossfade.setTargetValue(1.0f);
+        }
+    }
+    
+    auto fewerStages = std::min(activeFilterStages, fadeTargetFilterStages);
+    auto moreStages = std::max(activeFilterStages, fadeTargetFilterStages);
+    auto isCrossfading = tierCrossfade.isSmoothing();
+    
+    if(isCrossfading)
+    {
+        // Gain of the longer cascade for each sample of this block
+        auto* gains = crossfadeGains.getWritePointer(0);
+        auto fadingToLonger = fadeTargetFilterStages == moreStages;
+        
+        for(int j=0; j<numSamples; j++)
+        {
+            auto gain = tierCrossfade.getNextValue();
+            gains[j] = fadingToLonger ? gain : 1.0f - gain;
+        }
+    }
     
     AudioBlock<float> block(buffer);
     
@@ -234,15 +329,35 @@ void BassicManagerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
         
         ProcessContextReplacing<float> context(channelBlock);
         auto filterArray = filterArrays.getUnchecked(filterCounter);
-        for(int j=0; j<8; j++)
+        for(int j=0; j<moreStages; j++)
         {
             auto filter = filterArray->getUnchecked(j);
+            
+            if(isCrossfading && j == fewerStages)
+                crossfadeBuffer.copyFrom(filterCounter, 0, buffer, i, 0, numSamples);
+            
             filter->process(context);
         }
         
+        if(isCrossfading)
+        {
+            // buffer holds the longer cascade, crossfadeBuffer the shorter one,
+            // mix them as shorter + gain * (longer - shorter)
+            auto* output = buffer.getWritePointer(i);
+            auto* shorter = crossfadeBuffer.getReadPointer(filterCounter);
+            
+            juce::FloatVectorOperations::subtract(output, shorter, numSamples);
+            juce::FloatVectorOperations::multiply(output, crossfadeGains.getReadPointer(0), numSamples);
+            juce::FloatVectorOperations::add(output, shorter, numSamples);
+        }
+        
         filterCounter++;
     }
     
+    // Once the ramp reaches the end only the new order is left
+    if(isCrossfading && ! tierCrossfade.isSmoothing())
+        activeFilterStages = fadeTargetFilterStages;
+    
     // Replace the LFE channel with its low-passed version
     // apply +10dB of gain
     // then add the summed low pass content
@@ -256,16 +371,35 @@ void BassicManagerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
     buffer.addFrom(CHANNELS::LFE, 0, sumBuffer, 0, 0, buffer.getNumSamples());
         
     lfeLowPassFrequency.setTargetValue(*parameters.getRawParameterValue("lfeLowPassFrequency"));
-    lfeLowPassFrequency.getNextValue();
-    
-    if(lfeLowPassFrequency.isSmoothing())
-        lfeLowPassFilter.setCutoffFrequency(lfeLowPassFrequency.getNextValue());
-    
     crossoverFrequency.setTargetValue(*parameters.getRawParameterValue("crossoverFrequency"));
-    crossoverFrequency.getNextValue();
     
-    if(crossoverFrequency.isSmoothing())
-        updateCrossoverFrequency(getSampleRate());
+    if(LoadGovernor::usesParameterSmoothing(loadGovernor.getTier()))
+    {
+        lfeLowPassFrequency.getNextValue();
+        
+        if(lfeLowPassFrequency.isSmoothing())
+            lfeLowPassFilter.setCutoffFrequency(lfeLowPassFrequency.getNextValue());
+        
+        crossoverFrequency.getNextValue();
+        
+        if(crossoverFrequency.isSmoothing())
+            updateCrossoverFrequency(getSampleRate());
+    }
+    else
+    {
+        // Skip the ramp and redesign the filters once, straight at the target
+        if(lfeLowPassFrequency.isSmoothing())
+        {
+            lfeLowPassFrequency.setCurrentAndTargetValue(lfeLowPassFrequency.getTargetValue());
+            lfeLowPassFilter.setCutoffFrequency(lfeLowPassFrequency.getCurrentValue());
+        }
+        
+        if(crossoverFrequency.isSmoothing())
+        {
+            crossoverFrequency.setCurrentAndTargetValue(crossoverFrequency.getTargetValue());
+            updateCrossoverFrequency(getSampleRate());
+        }
+    }
 }
 
 //==============================================================================
@@ -287,6 +421,10 @@ void BassicManagerAudioProcessor::getStateInformation (juce::MemoryBlock& destDa
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
     auto state = parameters.copyState();
+    
+    // The quality tier is a read-out of the governor rather than a setting
+    state.removeChild(state.getChildWithProperty("id", "qualityTier"), nullptr);
+    
            std::unique_ptr<juce::XmlElement> xml (state.createXml());
            copyXmlToBinary (*xml, destData);
 }
@@ -299,7 +437,13 @@ void BassicManagerAudioProcessor::setStateInformation (const void* data, int siz
      
             if (xmlState.get() != nullptr)
                 if (xmlState->hasTagName (parameters.state.getType()))
-                    parameters.replaceState (juce::ValueTree::fromXml (*xmlState));
+                {
+                    // Ignore any quality tier saved by older versions, the governor owns it
+                    // and processBlock keeps the parameter in step with it
+                    auto state = juce::ValueTree::fromXml (*xmlState);
+                    state.removeChild(state.getChildWithProperty("id", "qualityTier"), nullptr);
+                    parameters.replaceState (state);
+                }
 }
 
 //==============================================================================
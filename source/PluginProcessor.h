@@ -10,6 +10,7 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "LoadGovernor.h"
 
 using namespace juce::dsp;
 
@@ -58,7 +59,16 @@ public:
     
     void updateCrossoverFrequency(double sampleRate);
     
+    // Sets a parameter from its real-world value, clamped to the parameter's range
+    void setParameterValue(const juce::String& parameterID, float value);
+    
     enum CHANNELS { L, R, C, LFE, LS, RS};
+    
+    // Range of the crossover and LFE low pass frequency parameters, in Hz
+    static constexpr float minFrequency = 20.0f, maxFrequency = 250.0f;
+    
+    // How long a change of quality tier crossfades between cascades for, in seconds
+    static constexpr double tierCrossfadeTime = 0.02;
 
 private:
     //==============================================================================
@@ -70,6 +80,19 @@ private:
     
     juce::OwnedArray<juce::OwnedArray<IIR::Filter<float>>> filterArrays;
     LinkwitzRileyFilter<float> sumLowPassFilter, lfeLowPassFilter;
+    
+    // Optional CPU-load governor, trades crossover quality for headroom
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+    LoadGovernor loadGovernor;
+    juce::AudioParameterChoice* qualityTierParameter;
+    int activeFilterStages, fadeTargetFilterStages;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> tierCrossfade;
+    juce::AudioBuffer<float> crossfadeBuffer, crossfadeGains;
+    
+    void updateQualityTier(int numSamples);
+    
+    // Lets the tests drive the governor between blocks
+    friend struct LoadGovernorTestAccess;
         
     
     
@@ -0,0 +1,216 @@
+#include "helpers/reference_processor.h"
+#include "helpers/test_helpers.h"
+#include <OfflineRenderer.h>
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+
+// Every processing path is run on the same random material and compared
+// against ReferenceProcessor. Errors are reported per channel on failure,
+// run the Tests binary with -s to see them for passing runs too.
+
+struct RenderSettings {
+    double sampleRate;
+    int blockSize;
+    float crossoverFrequency;
+    float lfeLowPassFrequency;
+};
+
+struct RenderPath {
+    const char* name;
+    std::function<void (juce::AudioBuffer<float>&, const RenderSettings&, juce::Random&)> render;
+};
+
+struct ChannelError {
+    float maxAbsError;
+    float nullDepthDecibels;
+};
+
+enum class SignalType { Noise, Sine, Impulses, Silence };
+
+static std::unique_ptr<BassicManagerAudioProcessor> createProcessor(const RenderSettings& settings)
+{
+    auto processor = std::make_unique<BassicManagerAudioProcessor>();
+    processor->setParameterValue("crossoverFrequency", settings.crossoverFrequency);
+    processor->setParameterValue("lfeLowPassFrequency", settings.lfeLowPassFrequency);
+    processor->prepareToPlay(settings.sampleRate, settings.blockSize);
+    return processor;
+}
+
+static const std::vector<RenderPath>& getRenderPaths()
+{
+    static const std::vector<RenderPath> paths {
+        { "processBlock", [] (auto& buffer, auto& settings, auto&) {
+            auto processor = createProcessor(settings);
+            renderInBlocks(*processor, buffer, [&] { return settings.blockSize; });
+        } },
+        { "processBlock with variable block sizes", [] (auto& buffer, auto& settings, auto& random) {
+            auto processor = createProcessor(settings);
+            renderInBlocks(*processor, buffer, [&] { return 1 + random.nextInt(settings.blockSize); });
+        } },
+        { "OfflineRenderer", [] (auto& buffer, auto& settings, auto&) {
+            OfflineRenderer::Settings offlineSettings;
+            offlineSettings.sampleRate = settings.sampleRate;
+            offlineSettings.crossoverFrequency = settings.crossoverFrequency;
+            offlineSettings.lfeLowPassFrequency = settings.lfeLowPassFrequency;
+            offlineSettings.blockSize = settings.blockSize;
+            offlineSettings.chunkSize = buffer.getNumSamples() / 8 + 1;
+
+            juce::AudioBuffer<float> output;
+            CHECK(OfflineRenderer::render(buffer, output, offlineSettings).wasOk());
+            buffer.makeCopyOf(output);
+        } },
+    };
+
+    return paths;
+}
+
+static void fillChannel(juce::AudioBuffer<float>& buffer, int channel, SignalType type, double sampleRate, juce::Random& random)
+{
+    auto samples = buffer.getWritePointer(channel);
+    buffer.clear(channel, 0, buffer.getNumSamples());
+
+    switch(type)
+    {
+        case SignalType::Noise:
+            for(int i=0; i<buffer.getNumSamples(); ++i)
+                samples[i] = random.nextFloat() - 0.5f;
+            break;
+
+        case SignalType::Sine:
+        {
+            // Log-distributed between 10Hz and a bit below Nyquist
+            auto frequency = 10.0 * std::pow(sampleRate / 25.0, random.nextDouble());
+            auto angleIncrement = frequency * juce::MathConstants<double>::twoPi / sampleRate;
+            auto phase = random.nextDouble() * juce::MathConstants<double>::twoPi;
+
+            for(int i=0; i<buffer.getNumSamples(); ++i)
+                samples[i] = 0.5f * (float) std::sin(phase + angleIncrement * i);
+            break;
+        }
+
+        case SignalType::Impulses:
+            for(int i=random.nextInt(1000); i<buffer.getNumSamples(); i+=1 + random.nextInt((int) sampleRate / 10))
+                samples[i] = random.nextBool() ? 1.0f : -1.0f;
+            break;
+
+        case SignalType::Silence:
+            break;
+    }
+}
+
+static ChannelError compareChannel(const juce::AudioBuffer<float>& reference, const juce::AudioBuffer<float>& candidate, int channel)
+{
+    double maxAbsError = 0.0, errorEnergy = 0.0, referenceEnergy = 0.0;
+
+    for(int i=0; i<reference.getNumSamples(); ++i)
+    {
+        double error = candidate.getSample(channel, i) - reference.getSample(channel, i);
+        maxAbsError = std::max(maxAbsError, std::abs(error));
+        errorEnergy += error * error;
+        referenceEnergy += (double) reference.getSample(channel, i) * reference.getSample(channel, i);
+    }
+
+    // Null depth is relative to the reference, or to full scale when the reference is silent
+    auto errorRMS = std::sqrt(errorEnergy / reference.getNumSamples());
+    auto referenceRMS = std::sqrt(referenceEnergy / reference.getNumSamples());
+    auto nullDepth = referenceRMS > 1.0e-6 ? errorRMS / referenceRMS : errorRMS;
+
+    return { (float) maxAbsError, juce::Decibels::gainToDecibels((float) nullDepth, -200.0f) };
+}
+
+TEST_CASE("Processing paths match the scalar reference", "[differential]") {
+    juce::Random random(0xba55);
+
+    const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0 };
+    const auto maxAbsErrorThreshold = 1.0e-4f;
+    const auto nullDepthThreshold = -80.0f;
+
+    for(int trial=0; trial<8; trial++)
+    {
+        RenderSettings settings {
+            sampleRates[random.nextInt(4)],
+            1 + random.nextInt(2048),
+            20.0f + random.nextFloat() * 230.0f,
+            20.0f + random.nextFloat() * 230.0f
+        };
+
+        int lengthInSamples = (int) settings.sampleRate / 2;
+
+        juce::AudioBuffer<float> input(6, lengthInSamples);
+        for(int i=0; i<6; i++)
+            fillChannel(input, i, static_cast<SignalType> (random.nextInt(4)), settings.sampleRate, random);
+
+        juce::AudioBuffer<float> reference(input);
+        ReferenceProcessor(settings.sampleRate, settings.crossoverFrequency, settings.lfeLowPassFrequency).process(reference);
+
+        for(auto& path : getRenderPaths())
+        {
+            juce::AudioBuffer<float> output(input);
+            path.render(output, settings, random);
+
+            for(int i=0; i<6; i++)
+            {
+                auto error = compareChannel(reference, output, i);
+
+                INFO(path.name << ", trial " << trial
+                     << ": " << settings.sampleRate << "Hz, block size " << settings.blockSize
+                     << ", crossover " << settings.crossoverFrequency << "Hz, LFE low pass " << settings.lfeLowPassFrequency << "Hz");
+                INFO("channel " << i << ": max abs error " << error.maxAbsError << ", null depth " << error.nullDepthDecibels << "dB");
+
+                CHECK(error.maxAbsError <= maxAbsErrorThreshold);
+                CHECK(error.nullDepthDecibels <= nullDepthThreshold);
+            }
+        }
+    }
+}
+
+TEST_CASE("The first block uses the current parameter values", "[differential]") {
+    // Regression: prepareToPlay used to ramp in from the default frequencies,
+    // so the start of a render was filtered at the wrong crossover
+    RenderSettings settings { 48000.0, 512, 250.0f, 250.0f };
+
+    juce::AudioBuffer<float> input(6, settings.blockSize * 4);
+    input.clear();
+    for(int i=0; i<6; i++)
+        input.setSample(i, 0, 1.0f);
+
+    juce::AudioBuffer<float> reference(input);
+    ReferenceProcessor(settings.sampleRate, settings.crossoverFrequency, settings.lfeLowPassFrequency).process(reference);
+
+    juce::AudioBuffer<float> output(input);
+    auto processor = createProcessor(settings);
+    renderInBlocks(*processor, output, [&] { return settings.blockSize; });
+
+    for(int i=0; i<6; i++)
+    {
+        auto error = compareChannel(reference, output, i);
+
+        INFO("channel " << i << ": max abs error " << error.maxAbsError);
+        CHECK(error.maxAbsError <= 1.0e-4f);
+    }
+}
+
+TEST_CASE("Blocks shorter than the prepared size match full blocks", "[differential]") {
+    // Regression: the summed low-pass used to run over the whole of sumBuffer,
+    // pushing stale samples through the filter whenever a block was shorter
+    // than the size passed to prepareToPlay
+    juce::Random random(0x5b5b);
+    RenderSettings settings { 48000.0, 512, 80.0f, 120.0f };
+
+    juce::AudioBuffer<float> input(6, settings.blockSize * 16);
+    for(int i=0; i<6; i++)
+        fillChannel(input, i, SignalType::Noise, settings.sampleRate, random);
+
+    juce::AudioBuffer<float> fullBlocks(input);
+    auto processor = createProcessor(settings);
+    renderInBlocks(*processor, fullBlocks, [&] { return settings.blockSize; });
+
+    juce::AudioBuffer<float> shortBlocks(input);
+    processor = createProcessor(settings);
+    renderInBlocks(*processor, shortBlocks, [&] { return settings.blockSize / 8; });
+
+    auto error = compareChannel(fullBlocks, shortBlocks, BassicManagerAudioProcessor::CHANNELS::LFE);
+
+    INFO("LFE: max abs error " << error.maxAbsError);
+    CHECK(error.maxAbsError <= 1.0e-6f);
+}
@@ -0,0 +1,238 @@
+#include "helpers/test_helpers.h"
+#include <LoadGovernor.h>
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("Governor steps down under sustained overload", "[loadGovernor]") {
+    LoadGovernor governor;
+
+    double sampleRate = 48000.0;
+    int blockSize = 480;
+
+    governor.prepare(sampleRate);
+    REQUIRE(governor.getTier() == LoadGovernor::Full);
+
+    // A short spike shouldn't be enough to switch
+    for(int i=0; i<10; i++)
+        governor.update(0.95f, blockSize);
+
+    CHECK(governor.getTier() == LoadGovernor::Full);
+
+    // Staying overloaded for the degrade time drops one tier at a time
+    for(int i=0; i<(int) (governor.degradeTime * sampleRate) / blockSize; i++)
+        governor.update(0.95f, blockSize);
+
+    CHECK(governor.getTier() == LoadGovernor::Reduced);
+
+    for(int i=0; i<(int) (governor.degradeTime * sampleRate) / blockSize * 4; i++)
+        governor.update(0.95f, blockSize);
+
+    CHECK(governor.getTier() == LoadGovernor::Economy);
+}
+
+TEST_CASE("Governor holds its tier between thresholds", "[loadGovernor]") {
+    LoadGovernor governor;
+
+    double sampleRate = 48000.0;
+    int blockSize = 480;
+
+    governor.prepare(sampleRate);
+
+    for(int i=0; i<(int) (governor.degradeTime * sampleRate) / blockSize; i++)
+        governor.update(0.95f, blockSize);
+
+    REQUIRE(governor.getTier() == LoadGovernor::Reduced);
+
+    // Load in the hysteresis band neither degrades nor recovers
+    for(int i=0; i<(int) (governor.recoverTime * sampleRate) / blockSize * 2; i++)
+        governor.update(0.65f, blockSize);
+
+    CHECK(governor.getTier() == LoadGovernor::Reduced);
+
+    // Once there is headroom for the recover time we step back up
+    for(int i=0; i<(int) (governor.recoverTime * sampleRate) / blockSize; i++)
+        governor.update(0.2f, blockSize);
+
+    CHECK(governor.getTier() == LoadGovernor::Full);
+}
+
+TEST_CASE("Governor keeps working through long sessions", "[loadGovernor]") {
+    LoadGovernor governor;
+
+    double sampleRate = 192000.0;
+    int blockSize = 4096;
+
+    governor.prepare(sampleRate);
+
+    // Four hours of idling at the top tier is past the range of an int sample count
+    auto numBlocks = (juce::int64) (4.0 * 60.0 * 60.0 * sampleRate) / blockSize;
+    for(juce::int64 i=0; i<numBlocks; i++)
+        governor.update(0.1f, blockSize);
+
+    CHECK(governor.getTier() == LoadGovernor::Full);
+
+    // The same for sitting overloaded at the bottom tier
+    for(juce::int64 i=0; i<numBlocks; i++)
+        governor.update(0.95f, blockSize);
+
+    CHECK(governor.getTier() == LoadGovernor::Economy);
+
+    // Stepping back up still takes the recover time, not more or less
+    for(int i=0; i<(int) (governor.recoverTime * sampleRate) / blockSize - 1; i++)
+        governor.update(0.1f, blockSize);
+
+    CHECK(governor.getTier() == LoadGovernor::Economy);
+
+    governor.update(0.1f, blockSize);
+    governor.update(0.1f, blockSize);
+    CHECK(governor.getTier() == LoadGovernor::Reduced);
+}
+
+TEST_CASE("Lower tiers use shorter cascades", "[loadGovernor]") {
+    CHECK(LoadGovernor::getNumFilterStages(LoadGovernor::Full) == 8);
+    CHECK(LoadGovernor::getNumFilterStages(LoadGovernor::Reduced) < LoadGovernor::getNumFilterStages(LoadGovernor::Full));
+    CHECK(LoadGovernor::getNumFilterStages(LoadGovernor::Economy) < LoadGovernor::getNumFilterStages(LoadGovernor::Reduced));
+    CHECK_FALSE(LoadGovernor::usesParameterSmoothing(LoadGovernor::Economy));
+}
+
+// Thresholds that make the governor step every block, or never
+static void forceStepDown(LoadGovernor& governor)  { governor.overloadThreshold = -1.0f; governor.recoveryThreshold = -1.0f; governor.degradeTime = 0.0; }
+static void forceStepUp(LoadGovernor& governor)    { governor.overloadThreshold = 10.0f; governor.recoveryThreshold = 10.0f; governor.recoverTime = 0.0; }
+static void holdTier(LoadGovernor& governor)       { governor.overloadThreshold = 10.0f; governor.recoveryThreshold = -1.0f; }
+
+// The processor keeps its governor private, this reaches it between blocks
+struct LoadGovernorTestAccess
+{
+    static LoadGovernor& getGovernor(BassicManagerAudioProcessor& processor) { return processor.loadGovernor; }
+};
+
+static juce::AudioParameterChoice* getQualityTierParameter(BassicManagerAudioProcessor& processor)
+{
+    for(auto* parameter : processor.getParameters())
+        if(auto* choice = dynamic_cast<juce::AudioParameterChoice*> (parameter))
+            if(choice->getParameterID() == "qualityTier")
+                return choice;
+
+    return nullptr;
+}
+
+TEST_CASE("Tier changes are crossfaded and reported", "[loadGovernor]") {
+    double sampleRate = 48000.0;
+
+    // A 500Hz tone sits in the pass band of every tier, but each cascade order
+    // shifts its phase differently, so a switch that fades too quickly clicks
+    auto testFrequency = 500.0;
+    auto amplitude = 0.5f;
+
+    // The fade is timed, so it has to hold up however small the host's blocks are
+    for(int blockSize : { 16, 32, 480, 2048 })
+    {
+        INFO("block size " << blockSize);
+
+        BassicManagerAudioProcessor testPlugin;
+        testPlugin.setParameterValue("crossoverFrequency", BassicManagerAudioProcessor::maxFrequency);
+        testPlugin.setParameterValue("cpuGovernor", 1.0f);
+        testPlugin.prepareToPlay(sampleRate, blockSize);
+
+        auto& governor = LoadGovernorTestAccess::getGovernor(testPlugin);
+        auto* tierParameter = getQualityTierParameter(testPlugin);
+        REQUIRE(tierParameter != nullptr);
+
+        // Settle, then walk down to Economy and back up, holding each tier
+        // until its crossfade has finished
+        struct Step { void (*configure)(LoadGovernor&); LoadGovernor::Tier expectedTier; };
+        std::vector<Step> steps;
+
+        auto holdBlocks = (int) std::ceil(BassicManagerAudioProcessor::tierCrossfadeTime * sampleRate / blockSize) + 10;
+
+        auto addSteps = [&] (void (*configure)(LoadGovernor&), LoadGovernor::Tier tier) {
+            steps.push_back({ configure, tier });
+            for(int i=0; i<holdBlocks; i++)
+                steps.push_back({ holdTier, tier });
+        };
+
+        addSteps(holdTier, LoadGovernor::Full);
+        addSteps(forceStepDown, LoadGovernor::Reduced);
+        addSteps(forceStepDown, LoadGovernor::Economy);
+        addSteps(forceStepUp, LoadGovernor::Reduced);
+        addSteps(forceStepUp, LoadGovernor::Full);
+
+        juce::AudioBuffer<float> output(6, blockSize * (int) steps.size());
+        for(int i=0; i<6; i++)
+            for(int j=0; j<output.getNumSamples(); j++)
+                output.setSample(i, j, amplitude * (float) std::sin(juce::MathConstants<double>::twoPi * testFrequency * j / sampleRate));
+
+        size_t block = 0;
+        renderInBlocks(testPlugin, output, [&] {
+            // Check the tier of the block just rendered before setting up the next one
+            if(block > 0)
+            {
+                INFO("block " << block - 1);
+                CHECK(governor.getTier() == steps[block - 1].expectedTier);
+                CHECK(tierParameter->getIndex() == steps[block - 1].expectedTier);
+            }
+
+            steps[block++].configure(governor);
+            return blockSize;
+        });
+
+        CHECK(governor.getTier() == steps.back().expectedTier);
+        CHECK(tierParameter->getIndex() == steps.back().expectedTier);
+
+        // A click shows up as a spike in the second difference. Allow a little more
+        // than the input tone's own, a fade over a few tens of samples is many times this.
+        auto omega = juce::MathConstants<double>::twoPi * testFrequency / sampleRate;
+        auto maxCurvature = 1.5f * amplitude * (float) (omega * omega);
+
+        for(int i : { BassicManagerAudioProcessor::L, BassicManagerAudioProcessor::R, BassicManagerAudioProcessor::C,
+                      BassicManagerAudioProcessor::LS, BassicManagerAudioProcessor::RS })
+        {
+            float largestCurvature = 0.0f;
+            int largestCurvatureAt = 0;
+
+            // Skip the first block, where the filters start up from silence
+            for(int j=blockSize+2; j<output.getNumSamples(); j++)
+            {
+                auto curvature = std::abs(output.getSample(i, j) - 2.0f * output.getSample(i, j-1) + output.getSample(i, j-2));
+                if(curvature > largestCurvature)
+                {
+                    largestCurvature = curvature;
+                    largestCurvatureAt = j;
+                }
+            }
+
+            INFO("channel " << i << ": largest second difference " << largestCurvature << " at sample " << largestCurvatureAt);
+            CHECK(largestCurvature <= maxCurvature);
+        }
+    }
+}
+
+TEST_CASE("Non-realtime renders stay at the full tier", "[loadGovernor]") {
+    BassicManagerAudioProcessor testPlugin;
+
+    testPlugin.setParameterValue("cpuGovernor", 1.0f);
+    testPlugin.setNonRealtime(true);
+    testPlugin.prepareToPlay(48000.0, 480);
+
+    auto& governor = LoadGovernorTestAccess::getGovernor(testPlugin);
+    forceStepDown(governor);
+
+    juce::AudioBuffer<float> buffer(6, 480 * 10);
+    buffer.clear();
+    renderInBlocks(testPlugin, buffer, [] { return 480; });
+
+    CHECK(governor.getTier() == LoadGovernor::Full);
+    CHECK(getQualityTierParameter(testPlugin)->getIndex() == LoadGovernor::Full);
+}
+
+TEST_CASE("The quality tier isn't saved with the plugin state", "[loadGovernor]") {
+    BassicManagerAudioProcessor testPlugin;
+
+    juce::MemoryBlock state;
+    testPlugin.getStateInformation(state);
+
+    auto xml = BassicManagerAudioProcessor::getXmlFromBinary(state.getData(), (int) state.getSize());
+    REQUIRE(xml != nullptr);
+
+    CHECK(xml->getChildByAttribute("id", "crossoverFrequency") != nullptr);
+    CHECK(xml->getChildByAttribute("id", "qualityTier") == nullptr);
+}
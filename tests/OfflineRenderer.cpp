@@ -0,0 +1,290 @@
+#include "helpers/test_helpers.h"
+#include <OfflineRenderer.h>
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+
+// The error bound is on top of the float rounding both renders already have,
+// so allow a few ulps of the channel's peak for that
+static float getRoundingAllowance(const juce::AudioBuffer<float>& buffer, int channel)
+{
+    return 8.0f * buffer.getMagnitude(channel, 0, buffer.getNumSamples()) * std::numeric_limits<float>::epsilon();
+}
+
+TEST_CASE("Chunked render matches a sequential render", "[offlineRenderer]") {
+    juce::Random random(0x5151);
+
+    OfflineRenderer::Settings settings;
+    settings.sampleRate = 48000.0;
+    settings.crossoverFrequency = 80.0f;
+    settings.lfeLowPassFrequency = 120.0f;
+    settings.numThreads = 4;
+
+    int lengthInSamples = (int) settings.sampleRate * 10;
+
+    // Chunks well past the priming length, so most of them start from a primed state
+    settings.chunkSize = OfflineRenderer::getPrimingLength(settings) * 2;
+
+    juce::AudioBuffer<float> input(6, lengthInSamples);
+    for(int i=0; i<6; i++)
+        for(int j=0; j<lengthInSamples; j++)
+            input.setSample(i, j, random.nextFloat() * 2.0f - 1.0f);
+
+    // Sequential render through a single plugin instance
+    BassicManagerAudioProcessor testPlugin;
+    testPlugin.setParameterValue("crossoverFrequency", settings.crossoverFrequency);
+    testPlugin.setParameterValue("lfeLowPassFrequency", settings.lfeLowPassFrequency);
+    testPlugin.prepareToPlay(settings.sampleRate, settings.blockSize);
+
+    juce::AudioBuffer<float> sequential(input);
+    renderInBlocks(testPlugin, sequential, [&] { return settings.blockSize; });
+
+    juce::AudioBuffer<float> chunked;
+    REQUIRE(OfflineRenderer::render(input, chunked, settings).wasOk());
+
+    REQUIRE(chunked.getNumChannels() == 6);
+    REQUIRE(chunked.getNumSamples() == lengthInSamples);
+
+    for(int i=0; i<6; i++)
+    {
+        float maxAbsError = 0.0f;
+        for(int j=0; j<lengthInSamples; j++)
+            maxAbsError = std::max(maxAbsError, std::abs(chunked.getSample(i, j) - sequential.getSample(i, j)));
+
+        INFO("channel " << i << ": max abs error " << maxAbsError);
+        CHECK(maxAbsError <= settings.errorBound + getRoundingAllowance(sequential, i));
+    }
+}
+
+TEST_CASE("Looser error bounds need less priming", "[offlineRenderer]") {
+    OfflineRenderer::Settings settings;
+    auto strictPriming = OfflineRenderer::getPrimingLength(settings);
+
+    settings.errorBound = 1.0e-3f;
+    CHECK(OfflineRenderer::getPrimingLength(settings) < strictPriming);
+
+    // Lower crossovers ring for longer
+    settings.crossoverFrequency = 20.0f;
+    CHECK(OfflineRenderer::getPrimingLength(settings) > 0);
+}
+
+TEST_CASE("Rendering a missing file fails", "[offlineRenderer]") {
+    auto missingFile = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("BassicManagerMissing.wav");
+    auto outputFile = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("BassicManagerOutput.wav");
+    missingFile.deleteFile();
+    outputFile.deleteFile();
+
+    auto result = OfflineRenderer::renderFile(missingFile, outputFile, {});
+
+    CHECK(result.failed());
+    CHECK_FALSE(outputFile.existsAsFile());
+}
+
+TEST_CASE("Invalid render settings are rejected", "[offlineRenderer]") {
+    juce::AudioBuffer<float> input(6, 4800), output;
+    input.clear();
+
+    OfflineRenderer::Settings settings;
+
+    juce::AudioBuffer<float> stereo(2, 4800);
+    stereo.clear();
+    CHECK(OfflineRenderer::render(stereo, output, settings).failed());
+
+    CHECK(OfflineRenderer::render(input, input, settings).failed());
+
+    settings.blockSize = 0;
+    CHECK(OfflineRenderer::render(input, output, settings).failed());
+    CHECK(OfflineRenderer::getPrimingLength(settings) == 0);
+
+    settings = {};
+    settings.sampleRate = 0.0;
+    CHECK(OfflineRenderer::render(input, output, settings).failed());
+    CHECK(OfflineRenderer::getPrimingLength(settings) == 0);
+}
+
+TEST_CASE("Frequencies are clamped like the plugin parameters", "[offlineRenderer]") {
+    juce::Random random(0xc1a4);
+
+    OfflineRenderer::Settings inRange;
+    inRange.crossoverFrequency = BassicManagerAudioProcessor::maxFrequency;
+    inRange.lfeLowPassFrequency = BassicManagerAudioProcessor::minFrequency;
+    inRange.chunkSize = 4096;
+
+    auto outOfRange = inRange;
+    outOfRange.crossoverFrequency = 500.0f;
+    outOfRange.lfeLowPassFrequency = 0.0f;
+
+    // Priming is sized for the frequencies the filters actually run at
+    CHECK(OfflineRenderer::getPrimingLength(outOfRange) == OfflineRenderer::getPrimingLength(inRange));
+
+    juce::AudioBuffer<float> input(6, 48000);
+    for(int i=0; i<6; i++)
+        for(int j=0; j<input.getNumSamples(); j++)
+            input.setSample(i, j, random.nextFloat() * 2.0f - 1.0f);
+
+    juce::AudioBuffer<float> expected, clamped;
+    REQUIRE(OfflineRenderer::render(input, expected, inRange).wasOk());
+    REQUIRE(OfflineRenderer::render(input, clamped, outOfRange).wasOk());
+
+    for(int i=0; i<6; i++)
+        for(int j=0; j<input.getNumSamples(); j++)
+            REQUIRE(clamped.getSample(i, j) == expected.getSample(i, j));
+}
+
+static void writeTestFile(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate, int bitsPerSample = 32)
+{
+    file.deleteFile();
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(file.createOutputStream().release(),
+                                                                              sampleRate,
+                                                                              (unsigned int) buffer.getNumChannels(),
+                                                                              bitsPerSample,
+                                                                              {},
+                                                                              0));
+    REQUIRE(writer != nullptr);
+    REQUIRE(writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples()));
+}
+
+TEST_CASE("Rendering a file matches rendering a buffer", "[offlineRenderer]") {
+    juce::Random random(0xf11e);
+    auto tempDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory);
+    auto sourceFile = tempDirectory.getChildFile("BassicManagerSource.wav");
+    auto outputFile = tempDirectory.getChildFile("BassicManagerOutput.wav");
+
+    OfflineRenderer::Settings settings;
+    settings.sampleRate = 48000.0;
+    settings.numThreads = 3;
+    settings.chunkSize = 10000;
+
+    juce::AudioBuffer<float> input(6, 96000);
+    for(int i=0; i<6; i++)
+        for(int j=0; j<input.getNumSamples(); j++)
+            input.setSample(i, j, random.nextFloat() - 0.5f);
+
+    writeTestFile(sourceFile, input, settings.sampleRate);
+
+    juce::AudioBuffer<float> expected;
+    REQUIRE(OfflineRenderer::render(input, expected, settings).wasOk());
+
+    auto result = OfflineRenderer::renderFile(sourceFile, outputFile, settings);
+    INFO(result.getErrorMessage());
+    REQUIRE(result.wasOk());
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(outputFile));
+
+    REQUIRE(reader != nullptr);
+    REQUIRE(reader->numChannels == 6);
+    REQUIRE(reader->lengthInSamples == input.getNumSamples());
+
+    juce::AudioBuffer<float> rendered(6, input.getNumSamples());
+    REQUIRE(reader->read(&rendered, 0, input.getNumSamples(), 0, true, true));
+
+    for(int i=0; i<6; i++)
+    {
+        float maxAbsError = 0.0f;
+        for(int j=0; j<input.getNumSamples(); j++)
+            maxAbsError = std::max(maxAbsError, std::abs(rendered.getSample(i, j) - expected.getSample(i, j)));
+
+        INFO("channel " << i << ": max abs error " << maxAbsError);
+        CHECK(maxAbsError <= 1.0e-6f);
+    }
+
+    reader.reset();
+    sourceFile.deleteFile();
+    outputFile.deleteFile();
+}
+
+TEST_CASE("File renders don't clip the boosted LFE", "[offlineRenderer]") {
+    auto tempDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory);
+    auto sourceFile = tempDirectory.getChildFile("BassicManager16Bit.wav");
+    auto outputFile = tempDirectory.getChildFile("BassicManagerOutput.wav");
+
+    // A 16 bit source with a loud bass line on the LFE, +10dB takes it past full scale
+    juce::AudioBuffer<float> input(6, 48000);
+    input.clear();
+    for(int j=0; j<input.getNumSamples(); j++)
+        input.setSample(BassicManagerAudioProcessor::LFE, j, 0.5f * (float) std::sin(juce::MathConstants<double>::twoPi * 50.0 * j / 48000.0));
+
+    writeTestFile(sourceFile, input, 48000.0, 16);
+
+    auto result = OfflineRenderer::renderFile(sourceFile, outputFile, {});
+    INFO(result.getErrorMessage());
+    REQUIRE(result.wasOk());
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(outputFile));
+
+    REQUIRE(reader != nullptr);
+    CHECK(reader->usesFloatingPointData);
+    CHECK(reader->bitsPerSample == 32);
+
+    juce::AudioBuffer<float> rendered(6, (int) reader->lengthInSamples);
+    REQUIRE(reader->read(&rendered, 0, rendered.getNumSamples(), 0, true, true));
+    CHECK(rendered.getMagnitude(BassicManagerAudioProcessor::LFE, 0, rendered.getNumSamples()) > 1.0f);
+
+    reader.reset();
+    sourceFile.deleteFile();
+    outputFile.deleteFile();
+}
+
+TEST_CASE("A failed file render leaves the destination alone", "[offlineRenderer]") {
+    auto tempDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory);
+    auto stereoFile = tempDirectory.getChildFile("BassicManagerStereo.wav");
+    auto outputFile = tempDirectory.getChildFile("BassicManagerExisting.wav");
+
+    juce::AudioBuffer<float> stereo(2, 4800);
+    stereo.clear();
+    writeTestFile(stereoFile, stereo, 48000.0);
+
+    REQUIRE(outputFile.replaceWithText("keep me"));
+
+    CHECK(OfflineRenderer::renderFile(stereoFile, outputFile, {}).failed());
+    CHECK(outputFile.loadFileAsString() == "keep me");
+
+    stereoFile.deleteFile();
+    outputFile.deleteFile();
+}
+
+TEST_CASE("Chunked render stays within the error bound for full scale steps", "[offlineRenderer]") {
+    // A slow full scale square wave on every channel drives the filter states
+    // much harder than noise does
+    OfflineRenderer::Settings settings;
+    settings.sampleRate = 48000.0;
+    settings.crossoverFrequency = BassicManagerAudioProcessor::minFrequency;
+    settings.lfeLowPassFrequency = BassicManagerAudioProcessor::minFrequency;
+    settings.errorBound = 1.0e-4f;
+    settings.numThreads = 4;
+    settings.chunkSize = OfflineRenderer::getPrimingLength(settings) + 1;
+
+    int lengthInSamples = settings.chunkSize * 8;
+    int halfPeriod = (int) settings.sampleRate / 10 + 7;
+
+    juce::AudioBuffer<float> input(6, lengthInSamples);
+    for(int i=0; i<6; i++)
+        for(int j=0; j<lengthInSamples; j++)
+            input.setSample(i, j, (j / halfPeriod) % 2 == 0 ? 1.0f : -1.0f);
+
+    BassicManagerAudioProcessor testPlugin;
+    testPlugin.setParameterValue("crossoverFrequency", settings.crossoverFrequency);
+    testPlugin.setParameterValue("lfeLowPassFrequency", settings.lfeLowPassFrequency);
+    testPlugin.prepareToPlay(settings.sampleRate, settings.blockSize);
+
+    juce::AudioBuffer<float> sequential(input);
+    renderInBlocks(testPlugin, sequential, [&] { return settings.blockSize; });
+
+    juce::AudioBuffer<float> chunked;
+    REQUIRE(OfflineRenderer::render(input, chunked, settings).wasOk());
+
+    for(int i=0; i<6; i++)
+    {
+        float maxAbsError = 0.0f;
+        for(int j=0; j<lengthInSamples; j++)
+            maxAbsError = std::max(maxAbsError, std::abs(chunked.getSample(i, j) - sequential.getSample(i, j)));
+
+        INFO("channel " << i << ": max abs error " << maxAbsError);
+        CHECK(maxAbsError <= settings.errorBound + getRoundingAllowance(sequential, i));
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <PluginProcessor.h>
+
+/* A plain scalar, double precision model of the bass management graph in
+ * BassicManagerAudioProcessor::processBlock, used as ground truth when
+ * comparing faster processing paths against the current behaviour.
+ *
+ * - L, R, C, LS and RS go through 8 cascaded first order Butterworth high-passes
+ * - The satellite inputs are summed and low-passed with a 4th order Linkwitz-Riley
+ * - LFE is low-passed with a 4th order Linkwitz-Riley, boosted by 10dB and the
+ *   low-passed sum is added on top
+ *
+ * It deliberately shares no code with the plugin: the filters are designed
+ * from the analog prototypes with a prewarped bilinear transform and run
+ * one sample at a time.
+ */
+class ReferenceProcessor
+{
+public:
+    ReferenceProcessor (double sampleRateIn, double crossoverFrequencyIn, double lfeLowPassFrequencyIn)
+    {
+        auto n = std::tan (juce::MathConstants<double>::pi * crossoverFrequencyIn / sampleRateIn);
+
+        for (auto& channelStages : highPassStages)
+            for (auto& stage : channelStages)
+                stage = { 1.0 / (1.0 + n), -1.0 / (1.0 + n), (n - 1.0) / (n + 1.0) };
+
+        sumLowPass = makeLinkwitzRiley (sampleRateIn, crossoverFrequencyIn);
+        lfeLowPass = makeLinkwitzRiley (sampleRateIn, lfeLowPassFrequencyIn);
+    }
+
+    // State carries over between calls, so a signal can be fed in any number of pieces
+    void process (juce::AudioBuffer<float>& buffer)
+    {
+        using Channels = BassicManagerAudioProcessor::CHANNELS;
+        const int satellites[] = { Channels::L, Channels::R, Channels::C, Channels::LS, Channels::RS };
+        const auto lfeGain = std::pow (10.0, 10.0 / 20.0);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            double sum = 0.0;
+
+            for (int s = 0; s < 5; ++s)
+            {
+                double x = buffer.getSample (satellites[s], i);
+                sum += x;
+
+                for (auto& stage : highPassStages[(size_t) s])
+                    x = stage.process (x);
+
+                buffer.setSample (satellites[s], i, (float) x);
+            }
+
+            double lfe = buffer.getSample (Channels::LFE, i);
+            lfe = lfeLowPass[1].process (lfeLowPass[0].process (lfe)) * lfeGain;
+            lfe += sumLowPass[1].process (sumLowPass[0].process (sum));
+
+            buffer.setSample (Channels::LFE, i, (float) lfe);
+        }
+    }
+
+private:
+    struct FirstOrderSection
+    {
+        double b0 = 1.0, b1 = 0.0, a1 = 0.0, z1 = 0.0;
+
+        double process (double x)
+        {
+            auto y = b0 * x + z1;
+            z1 = b1 * x - a1 * y;
+            return y;
+        }
+    };
+
+    struct BiquadSection
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0, z1 = 0.0, z2 = 0.0;
+
+        double process (double x)
+        {
+            auto y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    // A 4th order Linkwitz-Riley low-pass is two identical Butterworth biquads
+    static std::array<BiquadSection, 2> makeLinkwitzRiley (double sampleRate, double frequency)
+    {
+        auto k = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+        auto norm = 1.0 / (1.0 + juce::MathConstants<double>::sqrt2 * k + k * k);
+
+        BiquadSection section;
+        section.b0 = k * k * norm;
+        section.b1 = 2.0 * section.b0;
+        section.b2 = section.b0;
+        section.a1 = 2.0 * (k * k - 1.0) * norm;
+        section.a2 = (1.0 - juce::MathConstants<double>::sqrt2 * k + k * k) * norm;
+
+        return { section, section };
+    }
+
+    std::array<std::array<FirstOrderSection, 8>, 5> highPassStages;
+    std::array<BiquadSection, 2> sumLowPass, lfeLowPass;
+};
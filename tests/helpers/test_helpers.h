@@ -29,3 +29,22 @@
     plugin.editorBeingDeleted (editor);
     delete editor;
 }
+
+/* Runs a whole buffer through the plugin the way a host would, one block at a
+ * time. nextBlockSize is asked for the size of each block, so tests can use a
+ * fixed size or vary it.
+ */
+[[maybe_unused]] static void renderInBlocks (BassicManagerAudioProcessor& processor, juce::AudioBuffer<float>& buffer, const std::function<int()>& nextBlockSize)
+{
+    juce::MidiBuffer midiBuffer;
+    juce::AudioBuffer<float> blockBuffer;
+
+    for (int i = 0; i < buffer.getNumSamples();)
+    {
+        auto subBlockSize = std::min (nextBlockSize(), buffer.getNumSamples() - i);
+        blockBuffer.setDataToReferTo (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), i, subBlockSize);
+
+        processor.processBlock (blockBuffer, midiBuffer);
+        i += subBlockSize;
+    }
+}